@@ -14,47 +14,56 @@
 
 #include <rtai_mbx.h>
 #include <rtai_sched.h>
+#include <rtai_shm.h>
 #include <sys/rtai_modbus.h>
 
+#include "Prozessabbild.h"
+
 MODULE_LICENSE("GPL");
  // Computer-Client, an dem gerade gearbeitet wird
 #define MODBUS_GUI "bs-pc1"
 
-// Hier sind die Sensoren der Bearbeitenstation aufgeführt
-#define IN_WERKSTUECK_IM_DREHTELLER 		1<<0
-#define IN_WERSTUEK_IN_BOHRVORRICHTUNG		1<<1
-#define IN_WERSTUEK_IN_MESSVORRICHTUNG		1<<2
-#define IN_BOHRER_OBEN						1<<3
-#define IN_BOHRER_UNTEN						1<<4
-#define IN_DREHTELLER_IN_POSITION			1<<5
-#define IN_PRUEFER_AUSSCHUSS_ERKANNT		1<<6
-
-// Hier sind die Aktoren der Bearbeitenstation aufgeführt
-#define OUT_BOHRER							1<<0
-#define OUT_DREHTELLER						1<<1
-#define OUT_BOHRER_RUNTERFAHREN				1<<2
-#define OUT_BOHRER_HOCHFAHREN				1<<3
-#define OUT_WERSTUECK_FESTHALTEN			1<<4
-#define OUT_PRUEFER_AUSFAHREN				1<<5
-#define OUT_AUSWERFER_OUTPUT				1<<6
-#define OUT_AUSWERFER_INPUT					1<<7
-
 // Allgemeine Definitionen
 #define JA 									1
 #define NEIN 								0
 #define SET 								1
 #define RESET 								0
 #define AUSCHUSS 									1
+#define STATISTIK_INTERVALL					100	// Ausgabe der Statistik alle n Takte
+#define BOHRER_PRAEDIKTIV					JA	// Bohrer anhand des Prüfergebnisses vorbereiten
 
 // MailBox Nachrichten (Inhalt)
 #define MB_AUSWERFER						10
 #define MB_PRUEFER							11
 #define MB_BOHRER							12
 #define MB_DREHTELLER						13
+#define MB_BOHRER_STARTEN					14	// Bohrvorgang starten (Antwort: MB_BOHRER)
+#define MB_BOHRER_VORBEREITEN				15	// Spindel vorab einschalten (keine Antwort)
+#define MB_BOHRER_ABBRECHEN					16	// Vorbereitung verwerfen (keine Antwort)
+
+// Laufzeit-Statistik und Invarianten-Überwachung
+// Wird ausschließlich vom Control-Task geschrieben.
+static struct {
+	unsigned long taktzyklen;			// Anzahl Drehungen des Drehtellers
+	unsigned long geprueft;				// gestartete Prüfvorgänge
+	unsigned long ausschuss;			// davon als Ausschuss erkannt
+	unsigned long gebohrt;				// gestartete Bohrvorgänge
+	unsigned long ausgeworfen;			// gestartete Auswerfvorgänge
+	unsigned long verletzungen;			// verletzte Invarianten
+	unsigned long verloren;				// Teile, die nicht mehr erkannt wurden
+	unsigned long hinzugefuegt;			// Teile, die ungeprüft hinzugekommen sind
+	RTIME laufzeit;						// Summe der Taktzeiten (Drehbeginn bis Ende der Synchronisation, in counts)
+} statistik;
 
 // Modbus-Knoten
 static int fd_node;
 
+// Zuletzt bekannte Position des Bohrers; wird nur von init_Aktoren und dem Bohrmaschinen-Task geschrieben
+static uint8_t bohrer_oben = NEIN;
+
+// Prozessabbild im Shared Memory für HMI, Logger, ... (siehe Prozessabbild.h)
+static struct prozessabbild *abbild;
+
 // Semaphore-Deklarierung
 static SEM sem;	//für sicheres Schreiben auf die Ausgänge
 
@@ -83,6 +92,13 @@ static void bohrmaschine(long);
 static void drehteller(long);
 static int init_Aktoren(int);
 static int writeOnModBus(uint8_t mask, uint8_t mode);
+static int readFromModBus(unsigned short *val);
+static void abbild_eingaenge_setzen(uint16_t eingaenge);
+static void abbild_ausgaenge_setzen(uint16_t ausgaenge);
+static void abbild_teile_setzen(const uint8_t *teile);
+static void abbild_station_setzen(uint8_t station, uint8_t zustand);
+static void invariante_verletzt(const char *text);
+static void statistik_ausgeben(void);
 
 /* Hier beginnt der Control-Task */
 static void control(long x) {
@@ -106,7 +122,24 @@ static void control(long x) {
 	uint8_t soll_gebohrt_werden = 0;
 	static int val = 0;
 
+	// Invarianten: Nur geprüfte Gutteile werden gebohrt, es geht kein Teil verloren.
+	// messteil_geprueft: Für das Teil in der Messvorrichtung liegt ein Prüfergebnis vor
+	// bohrteil_geprueft: Das Teil in der Bohrvorrichtung wurde im letzten Takt geprüft
+	uint8_t messteil_geprueft = NEIN;
+	uint8_t bohrteil_geprueft = NEIN;
+	uint8_t teile_im_umlauf = 0;	// geprüfte, aber noch nicht ausgeworfene Teile
+	uint8_t teile_erkannt;
+	RTIME taktbeginn = 0;
+
+	// Die Spindel läuft bereits während der Drehung an (siehe BOHRER_PRAEDIKTIV)
+	uint8_t bohrer_vorbereitet = NEIN;
+	uint8_t bohrer_gestartet;		// Bohrvorgang wurde direkt nach der Drehung gestartet
+
+	// Zustand der Werkstücke an den Positionen, wird im Prozessabbild veröffentlicht
+	uint8_t teile[lastPosition] = { TEIL_LEER };
+
 	rt_printk("control: Task started\n");
+	abbild_station_setzen(stationControl, STATION_AKTIV);
 
 	// Verbinde zu Modbusknoten
 	if ((fd_node = rt_modbus_connect("MODBUS-NODE")) == -1) {
@@ -141,10 +174,11 @@ static void control(long x) {
 
     // Initialiserung der lokalen Varaiblen
 		zuletztGebohrt = NEIN;
+		bohrer_gestartet = NEIN;
 		message_Counter = 0;
 
 		/* Einlesen der Eingänge*/
-		if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+		if (readFromModBus((unsigned short *) &val))
 			goto fail;
 
     // Wenn jetzt ein Werkstück in der Bohrvorrichtung liegt, muss der Auswerfer nach einem erneuten Drehvorgang
@@ -154,9 +188,43 @@ static void control(long x) {
 			rt_printk("Werkstueck in Bohrvorrichtung\n");
 		}
 
+    // Jedes geprüfte Teil muss in der Mess- oder Bohrvorrichtung liegen, bis es ausgeworfen wurde.
+		teile_erkannt = ((val & IN_WERSTUEK_IN_MESSVORRICHTUNG) == IN_WERSTUEK_IN_MESSVORRICHTUNG)
+				+ ((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG) == IN_WERSTUEK_IN_BOHRVORRICHTUNG);
+		if (teile_erkannt < teile_im_umlauf) {
+			statistik.verloren += teile_im_umlauf - teile_erkannt;
+			invariante_verletzt("Teil verloren");
+		} else if (teile_erkannt > teile_im_umlauf) {
+			// z.B. von Hand in die Mess- oder Bohrvorrichtung gelegt
+			statistik.hinzugefuegt += teile_erkannt - teile_im_umlauf;
+			rt_printk("Teilebilanz: ungeprueftes Teil hinzugekommen\n");
+		}
+		teile_im_umlauf = teile_erkannt;
+
     // Hier wird untersucht, ob der Drehteller drehen muss. Dabei werden alle Sensoren, die ein Werkstück erkennen abgefragt.
 		if (((val & IN_WERKSTUECK_IM_DREHTELLER) == IN_WERKSTUECK_IM_DREHTELLER) | ((val & IN_WERSTUEK_IN_MESSVORRICHTUNG) == IN_WERSTUEK_IN_MESSVORRICHTUNG)
 				| ((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG) == IN_WERSTUEK_IN_BOHRVORRICHTUNG)) {
+			// Taktzeit erfassen (Ende nach der Synchronisation der Tasks)
+			taktbeginn = rt_get_time();
+			if (++statistik.taktzyklen % STATISTIK_INTERVALL == 0)
+				statistik_ausgeben();
+
+			// Das Prüfergebnis wandert mit dem Teil von der Mess- in die Bohrvorrichtung
+			bohrteil_geprueft = messteil_geprueft;
+			messteil_geprueft = NEIN;
+
+#if BOHRER_PRAEDIKTIV == JA
+			// Das Prüfergebnis ist bereits eine Drehung vorher bekannt. Ist das ankommende Teil ein
+			// Gutteil, läuft die Spindel schon während der Drehung an. Ausschuss wird nicht vorbereitet.
+			if (((val & IN_WERSTUEK_IN_MESSVORRICHTUNG) == IN_WERSTUEK_IN_MESSVORRICHTUNG)
+					&& bohrteil_geprueft == JA && soll_gebohrt_werden == JA) {
+				letter_Bohrer = MB_BOHRER_VORBEREITEN;
+				rt_mbx_send(&mbox[mailBoxBohrmaschine], &letter_Bohrer, sizeof(letter_Bohrer));
+				bohrer_vorbereitet = JA;
+				rt_printk("Bereite Bohrvorgang vor\n");
+			}
+#endif
+
 			rt_mbx_send(&mbox[mailBoxDrehteller], &letter_Drehteller, sizeof(letter_Drehteller));
 			rt_printk("Starte Drehteller\n");
 			rt_mbx_receive(&mbox[mailBoxControl], &letter_Drehteller, sizeof(letter_Drehteller)); // Startet erst, wenn Mail im Postfach vorhanden
@@ -164,36 +232,87 @@ static void control(long x) {
 			if (letter_Drehteller == MB_DREHTELLER) {
 				rt_printk("Drehteller steht wieder\n");
 				}
+
+#if BOHRER_PRAEDIKTIV == JA
+			// Drehteller steht: Den vorbereiteten Bohrvorgang sofort starten, noch vor Auswerfer und Prüfer.
+			if (bohrer_vorbereitet == JA) {
+				if (readFromModBus((unsigned short *) &val))
+					goto fail;
+				if ((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG) == IN_WERSTUEK_IN_BOHRVORRICHTUNG) {
+					letter_Bohrer = MB_BOHRER_STARTEN;
+					rt_mbx_send(&mbox[mailBoxBohrmaschine], &letter_Bohrer, sizeof(letter_Bohrer));	//starte Bohrvorgang
+					message_Counter++;
+					statistik.gebohrt++;
+					bohrer_gestartet = JA;
+					rt_printk("Starte Bohrvorgang\n");
+				}
+			}
+#endif
 		}
 
 		if (zuletztGebohrt == JA) {
 			//Auswerfer besitzt keine Sensor und benutzt den Sensor der Bohrvorrichtung
 			rt_mbx_send(&mbox[mailBoxAuswerfer], &letter_Auswerfer, sizeof(letter_Auswerfer));		//Auswerfer für Test ausschalten!!!!!!!!!!!!!!!
 			message_Counter++;
+			statistik.ausgeworfen++;
+			if (teile_im_umlauf > 0)
+				teile_im_umlauf--;
 			rt_printk("Starte Auswerfvorgang\n");
 		}
 
 		//erneutes einlesen der Eingänge nach dem drehen des Drehtellers
-		if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+		if (readFromModBus((unsigned short *) &val))
 			goto fail;
 
     // Liegt ein Werkstueck unter der Prüfvorrichtung?
 		if (((val & IN_WERSTUEK_IN_MESSVORRICHTUNG)	== IN_WERSTUEK_IN_MESSVORRICHTUNG)) {
 			rt_mbx_send(&mbox[mailBoxPruefer], &letter_Pruefer, sizeof(letter_Pruefer));	//starte Messvorgang
 			message_Counter++;
+			statistik.geprueft++;
+			teile_im_umlauf++;
 			rt_printk("Starte Pruefvorgang\n");
 		}
 
     // Liegt ein Werkstueck in der Bohrvorrichtung?
     // Überprüfe zusätzlich, ob auch gebohrt werden soll. Ausschuss?
-		if (((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG) == IN_WERSTUEK_IN_BOHRVORRICHTUNG) && soll_gebohrt_werden == JA) {
+    // Ein Teil ohne Prüfergebnis wird nie gebohrt, es könnte ein Ausschussteil sein.
+		if (((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG) == IN_WERSTUEK_IN_BOHRVORRICHTUNG) && soll_gebohrt_werden == JA
+				&& bohrteil_geprueft == NEIN) {
+			invariante_verletzt("Bohrteil ohne Pruefergebnis");
+			soll_gebohrt_werden = NEIN;
+		}
+		if (bohrer_gestartet == JA) {
+			// läuft bereits seit dem Stillstand des Drehtellers
+		} else if (((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG) == IN_WERSTUEK_IN_BOHRVORRICHTUNG) && soll_gebohrt_werden == JA) {
+			letter_Bohrer = MB_BOHRER_STARTEN;
 			rt_mbx_send(&mbox[mailBoxBohrmaschine], &letter_Bohrer, sizeof(letter_Bohrer));	//starte Bohrvorgang
 			message_Counter++;
+			statistik.gebohrt++;
 			rt_printk("Starte Bohrvorgang\n");
-		} else if (((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG) == IN_WERSTUEK_IN_BOHRVORRICHTUNG) && soll_gebohrt_werden == NEIN) {
+		} else if (bohrer_vorbereitet == JA) {
+			// Das erwartete Teil ist nicht angekommen: Spindel wieder ausschalten
+			letter_Bohrer = MB_BOHRER_ABBRECHEN;
+			rt_mbx_send(&mbox[mailBoxBohrmaschine], &letter_Bohrer, sizeof(letter_Bohrer));
+			rt_printk("Bohrvorbereitung abgebrochen\n");
+		}
+		bohrer_vorbereitet = NEIN;
+
+		if (((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG) == IN_WERSTUEK_IN_BOHRVORRICHTUNG) && soll_gebohrt_werden == NEIN) {
 			rt_printk("Werkstueck ist ein Ausschussteil 1\n");
 		}
 
+    // Prozessabbild: Das Teil aus der Bohrvorrichtung liegt jetzt am Auswerfer.
+		teile[posAuswerfer] = (zuletztGebohrt == JA) ? teile[posBohrvorrichtung] : TEIL_LEER;
+		if ((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG) != IN_WERSTUEK_IN_BOHRVORRICHTUNG)
+			teile[posBohrvorrichtung] = TEIL_LEER;
+		else if (bohrteil_geprueft == NEIN)
+			teile[posBohrvorrichtung] = TEIL_UNGEPRUEFT;
+		else
+			teile[posBohrvorrichtung] = (soll_gebohrt_werden == JA) ? TEIL_GUT : TEIL_AUSSCHUSS;
+		teile[posMessvorrichtung] = ((val & IN_WERSTUEK_IN_MESSVORRICHTUNG) == IN_WERSTUEK_IN_MESSVORRICHTUNG) ? TEIL_UNGEPRUEFT : TEIL_LEER;
+		teile[posDrehteller] = ((val & IN_WERKSTUECK_IM_DREHTELLER) == IN_WERKSTUECK_IM_DREHTELLER) ? TEIL_UNGEPRUEFT : TEIL_LEER;
+		abbild_teile_setzen(teile);
+
     // Diese for-Schleife synchronisiert die antwortenden Mailboxen
 		for(counter_var = 0; counter_var < message_Counter; message_Counter--){
 			rt_mbx_receive(&mbox[mailBoxControl], &letter_Control, sizeof(letter_Control)); //Warte bis Auswerfvorgang beendet wurde
@@ -221,14 +340,28 @@ static void control(long x) {
 				if (letter_Control == MB_PRUEFER) {
 					rt_printk("Pruefvorgang gestoppt\n");
 					}
+				messteil_geprueft = JA;
 				if( letter_Control == AUSCHUSS){
 					rt_printk("Pruefvorgang gestoppt und Ausschuss erkannt\n");
+					statistik.ausschuss++;
 					soll_gebohrt_werden = NEIN;
 				}else{
 					soll_gebohrt_werden = JA;
 				}
 		  }
 		}
+
+		// Stillstandszeiten ohne Drehung zählen nicht zur Taktzeit
+		if (taktbeginn != 0) {
+			statistik.laufzeit += rt_get_time() - taktbeginn;
+			taktbeginn = 0;
+		}
+
+    // Prozessabbild: Auswerfer ist leer, das Teil in der Messvorrichtung hat sein Prüfergebnis.
+		teile[posAuswerfer] = TEIL_LEER;
+		if (messteil_geprueft == JA)
+			teile[posMessvorrichtung] = (soll_gebohrt_werden == JA) ? TEIL_GUT : TEIL_AUSSCHUSS;
+		abbild_teile_setzen(teile);
 	} //Ende while()
 
   // Sprungstelle, falls Fehler auftreten
@@ -236,6 +369,8 @@ static void control(long x) {
 	fail: rt_modbus_disconnect(fd_node);
 	rt_printk("control: MODBUS communication failed\n");
 	rt_printk("control: task exited\n");
+	abbild_station_setzen(stationControl, STATION_FEHLER);
+	statistik_ausgeben();
 
   // Lösche Tasks
 	rt_task_delete(&taskDrehteller);
@@ -275,6 +410,13 @@ static void __exit example_exit(void) {
   // Stoppe RT_Timer
 	stop_rt_timer();
 
+	statistik_ausgeben();
+
+  // Gebe Prozessabbild frei; Leser, die den Bereich noch eingebunden haben, erkennen das an der Kennung
+	abbild->kennung = 0;
+	smp_wmb();
+	rtai_kfree(nam2num(PROZESSABBILD_NAME));
+
 	rt_printk("rtai_example unloaded\n");
 	rt_printk("Sie muessen das Programm neu starten.\n");
 }
@@ -297,6 +439,21 @@ static int __init example_init(void) {
 			goto fail0;
 		}
 
+	/**
+	 * Prozessabbild im Shared Memory anlegen. Hat ein Leser den Bereich bereits
+	 * angelegt, liefert rtai_kmalloc diesen zurück; deshalb vollständig initialisieren.
+	 * Die Kennung wird zuletzt gesetzt und zeigt den Lesern ein gültiges Abbild an.
+	 * */
+	abbild = rtai_kmalloc(nam2num(PROZESSABBILD_NAME), sizeof(struct prozessabbild));
+	if (abbild == NULL) {
+		printk("Cannot allocate process image\n");
+		goto fail0;
+	}
+	memset(abbild, 0, sizeof(struct prozessabbild));
+	abbild->version = PROZESSABBILD_VERSION;
+	smp_wmb();
+	abbild->kennung = PROZESSABBILD_KENNUNG;
+
 	/* rt_task_init(RT_TASK *task, void (*rt_thread)(long), long data,
 	 * 				int stack_size, int priority, int uses_fpu,
 	 * 				void (*signal)(void))
@@ -343,6 +500,10 @@ static int __init example_init(void) {
 	fail1: rt_task_delete(&taskControl);
 
 	fail0: stop_rt_timer();
+	if (abbild != NULL) {
+		abbild->kennung = 0;
+		rtai_kfree(nam2num(PROZESSABBILD_NAME));
+	}
 	while (i-- > 0)
 		rt_mbx_delete(&mbox[i]);
 	rt_sem_delete(&sem);
@@ -365,6 +526,7 @@ static void auswerfer(long x) {
 
 	while (1) {
 		rt_mbx_receive(&mbox[mailBoxAuswerfer], &letter_Auswerfer, sizeof(letter_Auswerfer));		//Empfange Nachricht
+		abbild_station_setzen(stationAuswerfer, STATION_AKTIV);
 
     // Aktiviere Auswerfer
 		if (writeOnModBus(OUT_AUSWERFER_OUTPUT, SET) == -1)
@@ -376,10 +538,12 @@ static void auswerfer(long x) {
 			goto fail;
 
 		letter_Auswerfer = MB_AUSWERFER;
+		abbild_station_setzen(stationAuswerfer, STATION_BEREIT);
 		rt_mbx_send(&mbox[mailBoxControl], &letter_Auswerfer, sizeof(letter_Auswerfer));		//Bin fertig!
 	}
   // Wenn Fehler auftreten
 	fail: rt_printk("auswerfer: Modus Fehler\n");
+	abbild_station_setzen(stationAuswerfer, STATION_FEHLER);
 	rt_modbus_disconnect(fd_node);
 	rt_printk("auswerfer: MODBUS communication failed\n");
 	rt_printk("auswerfer: task exited\n");
@@ -410,6 +574,7 @@ static void pruefer(long x) {
 		uint8_t countSleepAusschuss = 0;
 		uint8_t ausschuss_erkannt = 0;
 		rt_mbx_receive(&mbox[mailBoxPruefer], &letter_Pruefer, sizeof(letter_Pruefer));		//Empfange Nachricht
+		abbild_station_setzen(stationPruefer, STATION_AKTIV);
 
 		if (writeOnModBus(OUT_PRUEFER_AUSFAHREN, SET) == -1)	//Prüfer herunterfahren
 			goto fail;
@@ -420,7 +585,7 @@ static void pruefer(long x) {
 			countSleepAusschuss++;
 			rt_sleep(50 * nano2count(1000000));
 
-			if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+			if (readFromModBus((unsigned short *) &val))
 				goto fail;
 			rt_printk("Noch in Schleife -> Pruefer\n");
 
@@ -441,16 +606,19 @@ static void pruefer(long x) {
 			letter_Pruefer = AUSCHUSS;
 			rt_sleep(100 * nano2count(1000000)); // Prüfer fährt sicher wieder hoch
 			ausschuss_erkannt = NEIN;
+			abbild_station_setzen(stationPruefer, STATION_BEREIT);
 			rt_mbx_send(&mbox[mailBoxControl], &letter_Pruefer, sizeof(letter_Pruefer));		//Ausschuss erkannt
 		} else {
 			letter_Pruefer = MB_PRUEFER;
 			rt_sleep(100 * nano2count(1000000));	// Prüfer fährt sicher wieder hoch
+			abbild_station_setzen(stationPruefer, STATION_BEREIT);
 			rt_mbx_send(&mbox[mailBoxControl], &letter_Pruefer, sizeof(letter_Pruefer));		//Bin fertig!
 		}
 		rt_printk("taskTwo received message in Funktion::::: %d\n",letter_Pruefer);
 	}
   // Wenn Fehler auftreten
 	fail: rt_printk("puefer: Modus Fehler\n");
+	abbild_station_setzen(stationPruefer, STATION_FEHLER);
 	rt_modbus_disconnect(fd_node);
 	rt_printk("puefer: MODBUS communication failed\n");
 	rt_printk("puefer: task exited\n");
@@ -475,24 +643,62 @@ static void bohrmaschine(long x) {
   static int val = 0;
   int cnt_Mail_Delete;
 	uint8_t letter_Bohrer;
+	uint8_t spindel_laeuft = NEIN;
+	uint8_t bohrer_in_position;
  // uint8_t bohrer_verzoegert_einschalten = 0;
 
 	while (1) {
 		rt_mbx_receive(&mbox[mailBoxBohrmaschine], &letter_Bohrer, sizeof(letter_Bohrer));		//Empfange Nachricht
 
+    // Während der Drehung: Spindel schon anlaufen lassen, damit sofort gebohrt werden kann.
+		if (letter_Bohrer == MB_BOHRER_VORBEREITEN) {
+			if (writeOnModBus(OUT_BOHRER, SET) == -1)
+				goto fail;
+			spindel_laeuft = JA;
+			abbild_station_setzen(stationBohrmaschine, STATION_VORBEREITET);
+			rt_printk("Bohrer vorab einschalten\n");
+			continue;
+		}
+
+    // Das vorbereitete Teil ist nicht angekommen (z.B. Ausschuss): Spindel wieder aus.
+		if (letter_Bohrer == MB_BOHRER_ABBRECHEN) {
+			if (writeOnModBus(OUT_BOHRER, RESET) == -1)
+				goto fail;
+			spindel_laeuft = NEIN;
+			abbild_station_setzen(stationBohrmaschine, STATION_BEREIT);
+			rt_printk("Bohrer ausschalten\n");
+			continue;
+		}
+
+		abbild_station_setzen(stationBohrmaschine, STATION_AKTIV);
+
+    // Steht der Bohrer laut letztem Zyklus oben, genügt ein einzelnes Einlesen zur Bestätigung.
+		bohrer_in_position = NEIN;
+#if BOHRER_PRAEDIKTIV == JA
+		if (bohrer_oben == JA) {
+			if (readFromModBus((unsigned short *) &val))
+				goto fail;
+			if ((val & IN_BOHRER_OBEN) == IN_BOHRER_OBEN)
+				bohrer_in_position = JA;
+		}
+#endif
+
     // Fahre den Bohrer nach oben, wenn er noch nicht ganz oben ist. -> Nur zur Sicherheit!
-		if (writeOnModBus(OUT_BOHRER_HOCHFAHREN, SET) == -1)
-			goto fail;
-		do{
-			rt_sleep(50 * nano2count(1000000));
-			if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+		if (bohrer_in_position == NEIN) {
+			if (writeOnModBus(OUT_BOHRER_HOCHFAHREN, SET) == -1)
 				goto fail;
-		}while((val & IN_BOHRER_OBEN) != IN_BOHRER_OBEN);
+			do{
+				rt_sleep(50 * nano2count(1000000));
+				if (readFromModBus((unsigned short *) &val))
+					goto fail;
+			}while((val & IN_BOHRER_OBEN) != IN_BOHRER_OBEN);
 
-		if (writeOnModBus(OUT_BOHRER_HOCHFAHREN, RESET) == -1)
-			goto fail;
+			if (writeOnModBus(OUT_BOHRER_HOCHFAHREN, RESET) == -1)
+				goto fail;
+		}
 
 			// Fahre jetzt den Bohrer nach unten...
+			bohrer_oben = NEIN;
 			if (writeOnModBus(OUT_BOHRER_RUNTERFAHREN, SET) == -1)
 				goto fail;
 			// und spanne jetzt das Werkstück.
@@ -500,13 +706,15 @@ static void bohrmaschine(long x) {
 				goto fail;
 			rt_printk("Spanne Werkstueck\n");
 
-				// schalte Bohrer bereits beim runterfahren ein.
-				rt_printk("Bohrer einschalten\n");
-				if (writeOnModBus(OUT_BOHRER, SET) == -1)
-					goto fail;
+				// schalte Bohrer bereits beim runterfahren ein, falls er nicht schon läuft.
+				if (spindel_laeuft == NEIN) {
+					rt_printk("Bohrer einschalten\n");
+					if (writeOnModBus(OUT_BOHRER, SET) == -1)
+						goto fail;
+				}
 			do{
 				rt_sleep(50 * nano2count(1000000));
-				if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+				if (readFromModBus((unsigned short *) &val))
 					goto fail;
 			}while((val & IN_BOHRER_UNTEN) != IN_BOHRER_UNTEN);
 
@@ -518,15 +726,17 @@ static void bohrmaschine(long x) {
 				goto fail;
 			do{
 				rt_sleep(50 * nano2count(1000000));
-				if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+				if (readFromModBus((unsigned short *) &val))
 					goto fail;
 			}while((val & IN_BOHRER_OBEN) != IN_BOHRER_OBEN);
 
 			if (writeOnModBus(OUT_BOHRER_HOCHFAHREN, RESET) == -1)
 				goto fail;
+			bohrer_oben = JA;
 			// Bohrer ausschalten
 			if (writeOnModBus(OUT_BOHRER, RESET) == -1)
 				goto fail;
+			spindel_laeuft = NEIN;
 			rt_printk("Bohrer ausschalten\n");
 
 			if (writeOnModBus(OUT_WERSTUECK_FESTHALTEN, RESET) == -1)
@@ -535,11 +745,13 @@ static void bohrmaschine(long x) {
 
 
 			letter_Bohrer = MB_BOHRER;
+		abbild_station_setzen(stationBohrmaschine, STATION_BEREIT);
 		rt_mbx_send(&mbox[mailBoxControl], &letter_Bohrer, sizeof(letter_Bohrer));		//Bin fertig!
 
 	}
   // Fehlerfall
 	fail: rt_printk("bohrer: Modus Fehler\n");
+	abbild_station_setzen(stationBohrmaschine, STATION_FEHLER);
 	rt_modbus_disconnect(fd_node);
 	rt_printk("bohrer: MODBUS communication failed\n");
 	rt_printk("bohrer: task exited\n");
@@ -567,6 +779,7 @@ static void drehteller(long x) {
 
 	while (1) {
 		rt_mbx_receive(&mbox[mailBoxDrehteller], &letter_Drehteller, sizeof(letter_Drehteller)); //Startet erst, wenn Mail im Postfach vorhanden
+		abbild_station_setzen(stationDrehteller, STATION_AKTIV);
     // starte Drehteller
 		if (writeOnModBus(OUT_DREHTELLER, SET) == -1)
 			goto fail;
@@ -574,7 +787,7 @@ static void drehteller(long x) {
     // Überprüfe, ob Drehteller seine Position bereits verlassen hat.
 		do {
 			rt_sleep(50 * nano2count(1000000));
-			if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+			if (readFromModBus((unsigned short *) &val))
 				goto fail;
 		} while ((val & IN_DREHTELLER_IN_POSITION) == IN_DREHTELLER_IN_POSITION);
 
@@ -583,16 +796,18 @@ static void drehteller(long x) {
 
 		do {
 			rt_sleep(50 * nano2count(1000000));
-			if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+			if (readFromModBus((unsigned short *) &val))
 				goto fail;
 		} while ((val & IN_DREHTELLER_IN_POSITION) != IN_DREHTELLER_IN_POSITION);
 
 		rt_sleep(100 * nano2count(1000000)); //zum Erreichen der Endposition
 		letter_Drehteller = MB_DREHTELLER;
+		abbild_station_setzen(stationDrehteller, STATION_BEREIT);
 		rt_mbx_send(&mbox[mailBoxControl], &letter_Drehteller, sizeof(letter_Drehteller));		//Bin fertig!
 	}
   // Fehlerfall
 	fail: rt_printk("drehteller: Modus Fehler\n");
+	abbild_station_setzen(stationDrehteller, STATION_FEHLER);
 	rt_modbus_disconnect(fd_node);
 	rt_printk("drehteller: MODBUS communication failed\n");
 	rt_printk("drehteller: task exited\n");
@@ -640,6 +855,7 @@ static int writeOnModBus(uint8_t mask, uint8_t mode) {
 #endif
 	if (rt_modbus_set(fd_node, DIGITAL_OUT, 0, val))
 		return -1;
+	abbild_ausgaenge_setzen(val);
 
 	/* Weiteres Problem: Wird nach dem Schreiben der Ausgaenge der Zustand der
 	 * Ausgaenge eher wieder eingelesen, als die Ausgaenge physikalisch aktiv
@@ -670,10 +886,82 @@ static int writeOnModBus(uint8_t mask, uint8_t mode) {
 	return 0;
 }
 
+/* Einlesen der Eingänge; das Ergebnis wird zusätzlich im Prozessabbild veröffentlicht. */
+static int readFromModBus(unsigned short *val) {
+	if (rt_modbus_get(fd_node, DIGITAL_IN, 0, val))
+		return -1;
+	abbild_eingaenge_setzen(*val);
+	return 0;
+}
+
+/* Schreiben in das Prozessabbild (Seqlock, siehe Prozessabbild.h)
+ *
+ * Der Sequenzzähler ist während des Schreibens ungerade. Mehrere RT-Tasks
+ * schreiben, deshalb wird der kurze Abschnitt unter gesperrten Interrupts
+ * ausgeführt statt mit einem Semaphor: Die Tasks blockieren dabei nie.
+ */
+static unsigned long abbild_schreiben_beginnen(void) {
+	unsigned long flags = rt_global_save_flags_and_cli();
+	abbild->sequenz++;
+	smp_wmb();
+	return flags;
+}
+
+static void abbild_schreiben_beenden(unsigned long flags) {
+	smp_wmb();
+	abbild->sequenz++;
+	rt_global_restore_flags(flags);
+}
+
+static void abbild_eingaenge_setzen(uint16_t eingaenge) {
+	unsigned long flags = abbild_schreiben_beginnen();
+	abbild->eingaenge = eingaenge;
+	abbild_schreiben_beenden(flags);
+}
+
+static void abbild_ausgaenge_setzen(uint16_t ausgaenge) {
+	unsigned long flags = abbild_schreiben_beginnen();
+	abbild->ausgaenge = ausgaenge;
+	abbild_schreiben_beenden(flags);
+}
+
+static void abbild_teile_setzen(const uint8_t *teile) {
+	unsigned long flags = abbild_schreiben_beginnen();
+	memcpy(abbild->teile, teile, sizeof(abbild->teile));
+	abbild_schreiben_beenden(flags);
+}
+
+static void abbild_station_setzen(uint8_t station, uint8_t zustand) {
+	unsigned long flags = abbild_schreiben_beginnen();
+	abbild->stationen[station] = zustand;
+	abbild_schreiben_beenden(flags);
+}
+
+/* Meldet eine verletzte Invariante der Anlage.
+ * Die Anzahl der Verletzungen wird in der Statistik mitgezählt. Darf nur
+ * vom Control-Task aufgerufen werden, die Statistik ist nicht gesperrt.
+ */
+static void invariante_verletzt(const char *text) {
+	statistik.verletzungen++;
+	rt_printk("Invariante verletzt: %s\n", text);
+}
+
+/* Gibt die Laufzeit-Statistik aus. Die mittlere Taktzeit ergibt sich aus
+ * laufzeit / taktzyklen (Division im Kernel vermeiden).
+ */
+static void statistik_ausgeben(void) {
+	rt_printk("Statistik: %lu Takte, %lld ns Laufzeit\n", statistik.taktzyklen,
+			(long long) count2nano(statistik.laufzeit));
+	rt_printk("Statistik: %lu geprueft, %lu Ausschuss, %lu gebohrt, %lu ausgeworfen\n",
+			statistik.geprueft, statistik.ausschuss, statistik.gebohrt, statistik.ausgeworfen);
+	rt_printk("Statistik: %lu Invarianten verletzt, %lu Teile verloren, %lu hinzugekommen\n",
+			statistik.verletzungen, statistik.verloren, statistik.hinzugefuegt);
+}
+
 static int init_Aktoren(int fd_node) {
   // lokale Variablen für die eingelesenen Sensorwerte
   // und für die Größe der Mails
-	uint8_t val;
+	unsigned short val;
 	uint8_t letter_Drehteller;
 	uint8_t letter_Auswerfer;
 	uint8_t zuletztGebohrt;
@@ -683,9 +971,13 @@ static int init_Aktoren(int fd_node) {
 				return -1;
 			do{
 				rt_sleep(50 * nano2count(1000000));
-				if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+				if (readFromModBus(&val))
 					return -1;
 			}while((val & IN_BOHRER_OBEN) != IN_BOHRER_OBEN);
+	// Hochfahren beenden, sonst arbeitet der Ausgang gegen das spätere Runterfahren
+	if (writeOnModBus(OUT_BOHRER_HOCHFAHREN, RESET) == -1)
+				return -1;
+	bohrer_oben = JA;
 
 	//Drehteller leerfahren
 	while ((((val & IN_WERKSTUECK_IM_DREHTELLER) == IN_WERKSTUECK_IM_DREHTELLER) | ((val & IN_WERSTUEK_IN_MESSVORRICHTUNG)
@@ -693,7 +985,7 @@ static int init_Aktoren(int fd_node) {
 		zuletztGebohrt = NEIN;
 
 		/* Einlesen der Eingänge*/
-		if (rt_modbus_get(fd_node, DIGITAL_IN, 0, (unsigned short *) &val))
+		if (readFromModBus(&val))
 			return -1;
 
 		if ((val & IN_WERSTUEK_IN_BOHRVORRICHTUNG)== IN_WERSTUEK_IN_BOHRVORRICHTUNG) {
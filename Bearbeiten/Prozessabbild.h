@@ -0,0 +1,112 @@
+/* Prozessabbild der Bearbeitenstation im Shared Memory
+ *
+ * Das Kernelmodul veroeffentlicht hier das zuletzt eingelesene Eingangsabbild,
+ * die zuletzt geschriebenen Ausgaenge, den Zustand der Werkstuecke an jeder
+ * Position und den Zustand der einzelnen Tasks. Externe Programme (HMI, Logger,
+ * ...) lesen das Abbild, ohne den Modbus-Knoten zusaetzlich abzufragen.
+ *
+ * Das Abbild wird ueber einen Sequenzzaehler (Seqlock) geschuetzt: Ungerade
+ * Werte bedeuten, dass gerade geschrieben wird. Die RT-Tasks blockieren beim
+ * Schreiben nie, Leser wiederholen das Lesen, bis sie eine konsistente Kopie
+ * erhalten haben, hoechstens aber PROZESSABBILD_VERSUCHE mal.
+ *
+ * Achtung: RTAI bindet den Bereich auch im Userspace beschreibbar ein. Dass
+ * Leser nicht schreiben, stellt nur das const der Bibliothek sicher. Ein
+ * fehlerhafter Client kann das Abbild fuer alle Leser verfaelschen.
+ *
+ * rtai_malloc legt den Bereich an, falls das Modul nicht geladen ist. Ein
+ * gueltiges Abbild erkennt man daher nur an kennung == PROZESSABBILD_KENNUNG;
+ * das Modul setzt sie beim Laden und loescht sie beim Entladen.
+ */
+
+#ifndef PROZESSABBILD_H
+#define PROZESSABBILD_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
+// Name des Shared-Memory-Bereichs (max. 6 Zeichen, siehe nam2num)
+#define PROZESSABBILD_NAME					"BEABB"
+#define PROZESSABBILD_KENNUNG				0x42454142	// "BEAB", vom Modul gesetzt
+#define PROZESSABBILD_VERSION				1			// bei Aenderung von struct prozessabbild erhoehen
+#define PROZESSABBILD_VERSUCHE				1000		// max. Leseversuche fuer eine konsistente Kopie
+
+// Sensoren der Bearbeitenstation (Bits von DIGITAL_IN)
+#define IN_WERKSTUECK_IM_DREHTELLER			(1 << 0)
+#define IN_WERSTUEK_IN_BOHRVORRICHTUNG		(1 << 1)
+#define IN_WERSTUEK_IN_MESSVORRICHTUNG		(1 << 2)
+#define IN_BOHRER_OBEN						(1 << 3)
+#define IN_BOHRER_UNTEN						(1 << 4)
+#define IN_DREHTELLER_IN_POSITION			(1 << 5)
+#define IN_PRUEFER_AUSSCHUSS_ERKANNT		(1 << 6)
+
+// Aktoren der Bearbeitenstation (Bits von DIGITAL_OUT)
+#define OUT_BOHRER							(1 << 0)
+#define OUT_DREHTELLER						(1 << 1)
+#define OUT_BOHRER_RUNTERFAHREN				(1 << 2)
+#define OUT_BOHRER_HOCHFAHREN				(1 << 3)
+#define OUT_WERSTUECK_FESTHALTEN			(1 << 4)
+#define OUT_PRUEFER_AUSFAHREN				(1 << 5)
+#define OUT_AUSWERFER_OUTPUT				(1 << 6)
+#define OUT_AUSWERFER_INPUT					(1 << 7)
+
+// Positionen auf dem Drehteller
+enum position {
+	posDrehteller,			// Einlegeposition
+	posMessvorrichtung,
+	posBohrvorrichtung,
+	posAuswerfer,
+	lastPosition
+};
+
+// Zustand eines Werkstuecks an einer Position
+#define TEIL_LEER							0
+#define TEIL_UNGEPRUEFT						1
+#define TEIL_GUT							2
+#define TEIL_AUSSCHUSS						3
+
+// Tasks der Bearbeitenstation
+enum station {
+	stationControl,
+	stationAuswerfer,
+	stationPruefer,
+	stationBohrmaschine,
+	stationDrehteller,
+	lastStation
+};
+
+// Zustand eines Tasks
+#define STATION_BEREIT						0	// wartet auf Mail
+#define STATION_AKTIV						1	// Arbeitsschritt laeuft
+#define STATION_VORBEREITET					2	// Bohrer: Spindel laeuft vorab
+#define STATION_FEHLER						3	// Task wurde beendet
+
+struct prozessabbild {
+	volatile uint32_t kennung;			// PROZESSABBILD_KENNUNG, solange das Modul geladen ist
+	uint32_t version;					// PROZESSABBILD_VERSION
+	volatile uint32_t sequenz;			// ungerade: Schreibvorgang laeuft
+	uint16_t eingaenge;					// DIGITAL_IN, Bits siehe IN_*
+	uint16_t ausgaenge;					// DIGITAL_OUT, Bits siehe OUT_*
+	uint8_t teile[lastPosition];		// TEIL_*
+	uint8_t stationen[lastStation];		// STATION_*
+};
+
+#ifndef __KERNEL__
+/* Userspace-Bibliothek (ProzessabbildLeser.c) */
+
+// Bindet das Abbild ein. Liefert NULL, wenn das Kernelmodul nicht geladen ist
+// oder eine andere Version des Abbilds schreibt.
+const struct prozessabbild *prozessabbild_oeffnen(void);
+
+// Erstellt eine konsistente Kopie des Abbilds. Liefert -1, wenn das Modul
+// inzwischen entladen wurde oder nach PROZESSABBILD_VERSUCHE Versuchen keine
+// konsistente Kopie gelang, sonst 0.
+int prozessabbild_lesen(const struct prozessabbild *abbild, struct prozessabbild *kopie);
+
+void prozessabbild_schliessen(const struct prozessabbild *abbild);
+#endif
+
+#endif /* PROZESSABBILD_H */
@@ -0,0 +1,51 @@
+/* Userspace-Bibliothek zum Lesen des Prozessabbilds der Bearbeitenstation
+ *
+ * Bauen mit "make lib". Geschrieben wird ausschliesslich vom Kernelmodul;
+ * die Bibliothek greift nur lesend zu (siehe Einschraenkung in Prozessabbild.h).
+ */
+
+#include <string.h>
+#include <rtai_shm.h>
+
+#include "Prozessabbild.h"
+
+const struct prozessabbild *prozessabbild_oeffnen(void) {
+	struct prozessabbild *abbild;
+
+	// rtai_malloc legt den Bereich auch ohne geladenes Modul an (mit 0 gefuellt)
+	abbild = rtai_malloc(nam2num(PROZESSABBILD_NAME), sizeof(struct prozessabbild));
+	if (abbild == NULL)
+		return NULL;
+	if (abbild->kennung != PROZESSABBILD_KENNUNG || abbild->version != PROZESSABBILD_VERSION) {
+		rtai_free(nam2num(PROZESSABBILD_NAME), abbild);
+		return NULL;
+	}
+	return abbild;
+}
+
+int prozessabbild_lesen(const struct prozessabbild *abbild, struct prozessabbild *kopie) {
+	uint32_t sequenz;
+	int versuch;
+
+	// Lesen wiederholen, solange geschrieben wird oder sich der Zaehler waehrenddessen geaendert hat
+	for (versuch = 0; versuch < PROZESSABBILD_VERSUCHE; versuch++) {
+		sequenz = abbild->sequenz;
+		if (sequenz & 1)
+			continue;
+		__sync_synchronize();
+		memcpy(kopie, (const void *) abbild, sizeof(*kopie));
+		__sync_synchronize();
+		if (sequenz != abbild->sequenz)
+			continue;
+
+		if (kopie->kennung != PROZESSABBILD_KENNUNG)
+			return -1;
+		kopie->sequenz = sequenz;
+		return 0;
+	}
+	return -1;
+}
+
+void prozessabbild_schliessen(const struct prozessabbild *abbild) {
+	rtai_free(nam2num(PROZESSABBILD_NAME), (void *) abbild);
+}
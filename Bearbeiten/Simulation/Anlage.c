@@ -0,0 +1,339 @@
+/* Modell der Bearbeitenstation fuer die Simulation (siehe Anlage.h)
+ *
+ * Das Modell wird in Schritten von hoechstens 1 ms weitergerechnet. Bohrer,
+ * Pruefer und Auswerfer haben eine Position zwischen 0 (oben/eingefahren)
+ * und 1 (unten/ausgefahren).
+ */
+
+#include "Anlage.h"
+#include "../Prozessabbild.h"
+
+#define MS									1000000LL
+
+#define ANZAHL_EINGAENGE					7	// IN_* aus Prozessabbild.h
+
+// Plaetze auf dem Drehteller, in Drehrichtung
+#define PLATZ_EINLEGEN						0
+#define PLATZ_MESSEN						1
+#define PLATZ_BOHREN						2
+#define PLATZ_AUSWERFEN						3
+#define ANZAHL_PLAETZE						4
+
+// Art eines Werkstuecks im Modell
+#define WERKSTUECK_KEINS					0
+#define WERKSTUECK_GUT						1
+#define WERKSTUECK_AUSSCHUSS				2
+
+// Zustaende des Drehtellers
+#define TELLER_STEHT						0
+#define TELLER_ANLAUF						1	// Ausgang gesetzt, noch in Position
+#define TELLER_DREHT						2
+
+// Ein Ausschussteil ist zu hoch, der Pruefer erreicht seine Endlage nicht
+#define PRUEFER_HUB_AUSSCHUSS				0.7
+
+struct teil {
+	int art;							// WERKSTUECK_*
+	int gebohrt;
+};
+
+// Naechster Eintrag des Teilestroms. Alle Werte werden beim Ziehen des Eintrags
+// festgelegt, damit der Strom nicht vom Verhalten der Steuerung abhaengt.
+struct eintrag {
+	int art;							// WERKSTUECK_KEINS fuer eine Luecke
+	RTIME nachlauf;						// Wartezeit nach dem Stillstand des Drehtellers
+	RTIME pause;						// Wartezeit nach einer Luecke
+};
+
+static struct {
+	struct anlage_parameter parameter;
+	struct anlage_ergebnis ergebnis;
+	uint64_t zufall_teile;				// Teilestrom
+	uint64_t zufall_aktoren;			// Laufzeiten der Aktoren
+	uint64_t zufall_stoerung;			// Modbus-Latenz und Sensorrauschen
+	RTIME zeit;
+
+	// Streuung dieser Instanz
+	double anteil_luecken;
+	double anteil_ausschuss;
+	double faktor;						// Skalierung aller Laufzeiten
+
+	unsigned short ausgaenge;
+	struct teil platz[ANZAHL_PLAETZE];
+
+	int teller;
+	RTIME teller_bis;
+	int gespannt_gemeldet;
+
+	double bohrer, pruefer, auswerfer;
+	RTIME bohrer_fahrzeit, pruefer_fahrzeit, auswerfer_fahrzeit;
+	int bohrer_richtung;
+
+	unsigned long rest;					// noch nicht eingelegte Eintraege des Teilestroms
+	struct eintrag eintrag;
+	RTIME einlegen_ab;
+} a;
+
+/* xorshift64*, liefert eine Zahl in [0, 1) */
+static double zufall(uint64_t *zustand) {
+	*zustand ^= *zustand >> 12;
+	*zustand ^= *zustand << 25;
+	*zustand ^= *zustand >> 27;
+	return (*zustand * 2685821657736338717ULL >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Startwert des Generators "strom" (0..2) fuer diese Instanz.
+ * splitmix64, damit benachbarte Startwerte unabhaengige Folgen liefern. */
+static uint64_t zufall_start(int strom) {
+	uint64_t z = a.parameter.seed + 0x9e3779b97f4a7c15ULL * (3 * a.parameter.index + strom + 1);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	z ^= z >> 31;
+	return z != 0 ? z : 1;
+}
+
+/* Zufaellige Dauer um "basis" (in ms), skaliert mit dem Faktor der Instanz und +-20% gestreut */
+static RTIME dauer(uint64_t *zustand, double basis) {
+	return (RTIME) (basis * MS * a.faktor * (0.8 + 0.4 * zufall(zustand)));
+}
+
+/* Zieht den naechsten Eintrag des Teilestroms, immer mit gleich vielen Zufallszahlen */
+static void eintrag_ziehen(void) {
+	int luecke = zufall(&a.zufall_teile) < a.anteil_luecken;
+	int ausschuss = zufall(&a.zufall_teile) < a.anteil_ausschuss;
+
+	a.eintrag.art = luecke ? WERKSTUECK_KEINS : (ausschuss ? WERKSTUECK_AUSSCHUSS : WERKSTUECK_GUT);
+	a.eintrag.nachlauf = dauer(&a.zufall_teile, 800);
+	a.eintrag.pause = dauer(&a.zufall_teile, 2500);
+}
+
+void anlage_init(const struct anlage_parameter *parameter) {
+	a.parameter = *parameter;
+	a.ergebnis.index = parameter->index;
+
+	// Getrennte Generatoren: Teilestrom und Aktorlaufzeiten sind bei gleichem
+	// seed/index unabhaengig von der Steuerung und der Rauschrate gleich,
+	// zwei Varianten der Steuerung laufen also gepaart.
+	a.zufall_teile = zufall_start(0);
+	a.zufall_aktoren = zufall_start(1);
+	a.zufall_stoerung = zufall_start(2);
+
+	a.anteil_luecken = 0.3 * zufall(&a.zufall_teile);
+	a.anteil_ausschuss = 0.5 * zufall(&a.zufall_teile);
+	a.faktor = 0.8 + 0.7 * zufall(&a.zufall_teile);
+
+	a.rest = parameter->teile;
+	a.einlegen_ab = dauer(&a.zufall_teile, 1000);
+	eintrag_ziehen();
+
+	// Der Bohrer steht zu Beginn irgendwo
+	a.bohrer = zufall(&a.zufall_aktoren) < 0.5 ? 0.0 : zufall(&a.zufall_aktoren);
+	a.bohrer_fahrzeit = dauer(&a.zufall_aktoren, 350);
+	a.pruefer_fahrzeit = dauer(&a.zufall_aktoren, 80);
+	a.auswerfer_fahrzeit = dauer(&a.zufall_aktoren, 150);
+}
+
+static void teil_auswerfen(void) {
+	struct teil *teil = &a.platz[PLATZ_AUSWERFEN];
+
+	if (teil->art == WERKSTUECK_KEINS)
+		return;
+	a.ergebnis.ausgeworfen++;
+	if (teil->art == WERKSTUECK_GUT && teil->gebohrt == 0)
+		a.ergebnis.gut_nicht_gebohrt++;
+	teil->art = WERKSTUECK_KEINS;
+}
+
+static void teil_bohren(void) {
+	struct teil *teil = &a.platz[PLATZ_BOHREN];
+
+	if (a.teller != TELLER_STEHT) {
+		a.ergebnis.kollisionen++;
+		return;
+	}
+	if (teil->art == WERKSTUECK_KEINS)
+		return;
+	if ((a.ausgaenge & OUT_BOHRER) == 0) {
+		a.ergebnis.kollisionen++;
+		return;
+	}
+	a.ergebnis.gebohrt++;
+	if (teil->art == WERKSTUECK_AUSSCHUSS)
+		a.ergebnis.ausschuss_gebohrt++;
+	if (teil->gebohrt++ > 0)
+		a.ergebnis.doppelt_gebohrt++;
+}
+
+static void teller_weiter(void) {
+	struct teil uebrig = a.platz[PLATZ_AUSWERFEN];
+	int i;
+
+	// Ein Teil, das am Auswerfer vorbeifaehrt, ist verloren
+	if (uebrig.art != WERKSTUECK_KEINS)
+		a.ergebnis.verloren++;
+	for (i = ANZAHL_PLAETZE - 1; i > 0; i--)
+		a.platz[i] = a.platz[i - 1];
+	a.platz[PLATZ_EINLEGEN].art = WERKSTUECK_KEINS;
+	a.platz[PLATZ_EINLEGEN].gebohrt = 0;
+}
+
+/* Bewegt einen Aktor um dt in Richtung "ziel" und meldet das Erreichen der Endlage 1 */
+static int bewegen(double *position, double ziel, RTIME fahrzeit, RTIME dt) {
+	double vorher = *position;
+	double schritt = (double) dt / fahrzeit;
+
+	if (*position < ziel)
+		*position = (*position + schritt > ziel) ? ziel : *position + schritt;
+	else if (*position > ziel)
+		*position = (*position - schritt < ziel) ? ziel : *position - schritt;
+	return vorher < 1.0 && *position >= 1.0;
+}
+
+static void schritt(RTIME dt) {
+	int richtung;
+	double ziel;
+
+	// Drehteller
+	switch (a.teller) {
+	case TELLER_STEHT:
+		if (a.ausgaenge & OUT_DREHTELLER) {
+			a.teller = TELLER_ANLAUF;
+			a.teller_bis = a.zeit + dauer(&a.zufall_aktoren, 50);
+		}
+		break;
+	case TELLER_ANLAUF:
+		if ((a.ausgaenge & OUT_DREHTELLER) == 0) {
+			a.teller = TELLER_STEHT;
+		} else if (a.zeit >= a.teller_bis) {
+			a.teller = TELLER_DREHT;
+			a.teller_bis = a.zeit + dauer(&a.zufall_aktoren, 600);
+			a.gespannt_gemeldet = 0;
+			a.ergebnis.drehungen++;
+			if (a.bohrer > 0.0 || a.pruefer > 0.0 || a.auswerfer > 0.0)
+				a.ergebnis.kollisionen++;
+		}
+		break;
+	case TELLER_DREHT:
+		if (a.zeit >= a.teller_bis) {
+			teller_weiter();
+			a.teller = TELLER_STEHT;
+			a.einlegen_ab = a.zeit + a.eintrag.nachlauf;
+		}
+		break;
+	}
+	if (a.teller == TELLER_DREHT && (a.ausgaenge & OUT_WERSTUECK_FESTHALTEN) && !a.gespannt_gemeldet) {
+		a.ergebnis.drehen_gespannt++;
+		a.gespannt_gemeldet = 1;
+	}
+
+	// Bohrer: Bei widerspruechlichen Ausgaengen bleibt er stehen
+	richtung = 0;
+	if ((a.ausgaenge & OUT_BOHRER_RUNTERFAHREN) && !(a.ausgaenge & OUT_BOHRER_HOCHFAHREN))
+		richtung = 1;
+	else if ((a.ausgaenge & OUT_BOHRER_HOCHFAHREN) && !(a.ausgaenge & OUT_BOHRER_RUNTERFAHREN))
+		richtung = -1;
+	if (richtung != a.bohrer_richtung) {
+		a.bohrer_fahrzeit = dauer(&a.zufall_aktoren, 350);
+		a.bohrer_richtung = richtung;
+	}
+	if (richtung != 0 && bewegen(&a.bohrer, richtung > 0 ? 1.0 : 0.0, a.bohrer_fahrzeit, dt))
+		teil_bohren();
+
+	// Pruefer
+	ziel = 0.0;
+	if (a.ausgaenge & OUT_PRUEFER_AUSFAHREN)
+		ziel = (a.platz[PLATZ_MESSEN].art == WERKSTUECK_AUSSCHUSS && a.teller == TELLER_STEHT) ? PRUEFER_HUB_AUSSCHUSS : 1.0;
+	bewegen(&a.pruefer, ziel, a.pruefer_fahrzeit, dt);
+
+	// Auswerfer
+	if (bewegen(&a.auswerfer, (a.ausgaenge & OUT_AUSWERFER_OUTPUT) ? 1.0 : 0.0, a.auswerfer_fahrzeit, dt)
+			&& a.teller == TELLER_STEHT)
+		teil_auswerfen();
+
+	// Bediener legt das naechste Teil des Stroms ein
+	if (a.teller == TELLER_STEHT && a.platz[PLATZ_EINLEGEN].art == WERKSTUECK_KEINS && a.rest > 0
+			&& a.zeit >= a.einlegen_ab) {
+		a.rest--;
+		if (a.eintrag.art == WERKSTUECK_KEINS) {
+			a.einlegen_ab = a.zeit + a.eintrag.pause;
+		} else {
+			a.platz[PLATZ_EINLEGEN].art = a.eintrag.art;
+			a.ergebnis.eingelegt++;
+			if (a.eintrag.art == WERKSTUECK_AUSSCHUSS)
+				a.ergebnis.eingelegt_ausschuss++;
+		}
+		eintrag_ziehen();
+	}
+}
+
+void anlage_fortschreiten(RTIME bis) {
+	RTIME dt;
+
+	while (a.zeit < bis) {
+		dt = (bis - a.zeit < MS) ? bis - a.zeit : MS;
+		a.zeit += dt;
+		schritt(dt);
+	}
+}
+
+int anlage_fertig(void) {
+	int i;
+
+	if (a.rest > 0 || a.teller != TELLER_STEHT || a.ausgaenge != 0)
+		return 0;
+	for (i = 0; i < ANZAHL_PLAETZE; i++)
+		if (a.platz[i].art != WERKSTUECK_KEINS)
+			return 0;
+	return 1;
+}
+
+void anlage_ergebnis(struct anlage_ergebnis *ergebnis) {
+	*ergebnis = a.ergebnis;
+	ergebnis->simzeit = a.zeit;
+}
+
+unsigned short anlage_eingaenge(void) {
+	unsigned short wert = 0;
+	int i;
+
+	if (a.teller != TELLER_DREHT) {
+		wert |= IN_DREHTELLER_IN_POSITION;
+		if (a.platz[PLATZ_EINLEGEN].art != WERKSTUECK_KEINS)
+			wert |= IN_WERKSTUECK_IM_DREHTELLER;
+		if (a.platz[PLATZ_MESSEN].art != WERKSTUECK_KEINS)
+			wert |= IN_WERSTUEK_IN_MESSVORRICHTUNG;
+		if (a.platz[PLATZ_BOHREN].art != WERKSTUECK_KEINS)
+			wert |= IN_WERSTUEK_IN_BOHRVORRICHTUNG;
+	}
+	if (a.bohrer <= 0.0)
+		wert |= IN_BOHRER_OBEN;
+	if (a.bohrer >= 1.0)
+		wert |= IN_BOHRER_UNTEN;
+	if (a.pruefer >= 1.0)
+		wert |= IN_PRUEFER_AUSSCHUSS_ERKANNT;
+
+	// Sensorrauschen
+	if (a.parameter.rauschen > 0.0)
+		for (i = 0; i < ANZAHL_EINGAENGE; i++)
+			if (zufall(&a.zufall_stoerung) < a.parameter.rauschen)
+				wert ^= 1 << i;
+	return wert;
+}
+
+unsigned short anlage_ausgaenge(void) {
+	return a.ausgaenge;
+}
+
+void anlage_ausgaenge_setzen(unsigned short ausgaenge) {
+	if ((ausgaenge ^ a.ausgaenge) & OUT_PRUEFER_AUSFAHREN)
+		a.pruefer_fahrzeit = dauer(&a.zufall_aktoren, 80);
+	// Der Auswerfer faehrt per Feder deutlich schneller zurueck als aus
+	if ((ausgaenge ^ a.ausgaenge) & OUT_AUSWERFER_OUTPUT)
+		a.auswerfer_fahrzeit = (ausgaenge & OUT_AUSWERFER_OUTPUT) ? dauer(&a.zufall_aktoren, 150) : dauer(&a.zufall_aktoren, 20);
+	a.ausgaenge = ausgaenge;
+}
+
+RTIME anlage_modbus_latenz(void) {
+	return (RTIME) ((0.5 + 1.5 * zufall(&a.zufall_stoerung)) * MS);
+}
@@ -0,0 +1,66 @@
+/* Modell der Bearbeitenstation fuer die Simulation
+ *
+ * Der Drehteller hat vier Plaetze: Einlegen, Messvorrichtung, Bohrvorrichtung
+ * und Auswerfer. Ein Bediener legt Teile aus einem zufaelligen Strom
+ * (Gutteil, Ausschuss, Luecke) ein. Alle Aktoren haben zufaellig streuende
+ * Laufzeiten, die Sensoren koennen verrauscht werden.
+ *
+ * Das Modell prueft die Invarianten der Anlage:
+ *  - kein Ausschussteil wird gebohrt
+ *  - der Drehteller dreht nie, waehrend ein Werkstueck gespannt ist
+ *  - kein Teil geht verloren (jedes Teil wird am Auswerfer ausgeworfen)
+ */
+
+#ifndef ANLAGE_H
+#define ANLAGE_H
+
+#include <stdint.h>
+
+#include "rtai_stub.h"
+
+struct anlage_parameter {
+	unsigned long index;				// Nummer der Instanz
+	uint64_t seed;						// Startwert des Zufallsgenerators
+	unsigned long teile;				// Laenge des Teilestroms (inkl. Luecken)
+	double rauschen;					// Kippwahrscheinlichkeit pro Eingangsbit und Lesezugriff
+};
+
+struct anlage_ergebnis {
+	unsigned long index;
+	int abbruch;						// SIM_*
+	RTIME simzeit;						// virtuelle Laufzeit
+
+	// Teilestrom
+	unsigned long eingelegt;
+	unsigned long eingelegt_ausschuss;
+	unsigned long ausgeworfen;
+	unsigned long gebohrt;
+	unsigned long drehungen;
+
+	// Invarianten
+	unsigned long ausschuss_gebohrt;
+	unsigned long drehen_gespannt;
+	unsigned long verloren;
+
+	// Weitere Auffaelligkeiten
+	unsigned long kollisionen;			// Drehen mit ausgefahrenem Bohrer/Pruefer/Auswerfer, Bohren ohne Spindel
+	unsigned long gut_nicht_gebohrt;
+	unsigned long doppelt_gebohrt;
+
+	// Statistik des Kernelmoduls
+	unsigned long takte;
+	RTIME taktzeit;
+	unsigned long modul_verletzungen;
+};
+
+void anlage_init(const struct anlage_parameter *parameter);
+void anlage_fortschreiten(RTIME bis);
+int anlage_fertig(void);
+void anlage_ergebnis(struct anlage_ergebnis *ergebnis);
+
+unsigned short anlage_eingaenge(void);
+unsigned short anlage_ausgaenge(void);
+void anlage_ausgaenge_setzen(unsigned short ausgaenge);
+RTIME anlage_modbus_latenz(void);
+
+#endif /* ANLAGE_H */
@@ -0,0 +1,226 @@
+/* Simulation der Bearbeitenstation auf dem Entwicklungsrechner
+ *
+ * Die Tasks aus Beispielprojekt.c laufen unveraendert gegen die Nachbildung
+ * von RTAI und Modbus (rtai_stub.c) und das Anlagenmodell (Anlage.c).
+ * Jede Instanz bekommt einen eigenen, reproduzierbaren Teilestrom mit
+ * zufaelligen Laufzeiten und laeuft in einem eigenen Prozess; es laufen so
+ * viele Instanzen gleichzeitig, wie Kerne vorhanden sind. Teilestrom und
+ * Aktorlaufzeiten haengen nur von Seed und Instanz ab, zwei Varianten der
+ * Steuerung lassen sich mit gleichem -s also gepaart vergleichen.
+ *
+ * Sensorrauschen (-r, Wahrscheinlichkeit je Eingang und Lesezugriff) ist ein
+ * Stresstest und standardmaessig aus: Die Steuerung wertet jeden Eingang nach
+ * einem einzigen Lesezugriff aus und toleriert keine einzelnen Fehlmessungen.
+ * Mit -r 0.0001 werden u.a. Ausschussteile gebohrt und Teile verloren.
+ *
+ * Bauen mit "make sim", Aufruf z.B.:
+ *   ./simulation -n 10000 -t 200        10000 Instanzen mit je 200 Teilen
+ *   ./simulation -i 42                  Instanz 42 einzeln mit Ausgabe
+ *   ./simulation -r 0.0001              mit Sensorrauschen
+ *
+ * Der Rueckgabewert ist 1, wenn eine Invariante verletzt wurde oder eine
+ * Instanz nicht zu Ende gelaufen ist.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../Beispielprojekt.c"
+#include "Anlage.h"
+
+#define MAX_FEHLERHAFTE						10	// Anzahl der gemeldeten Instanzen
+
+struct optionen {
+	unsigned long instanzen;
+	unsigned long teile;
+	unsigned long prozesse;
+	uint64_t seed;
+	double rauschen;
+	long einzeln;						// -1: alle Instanzen
+};
+
+static int instanz_ende(void) {
+	return anlage_fertig();
+}
+
+static int instanz_fehlerhaft(const struct anlage_ergebnis *e) {
+	return e->abbruch != SIM_OK || e->ausschuss_gebohrt || e->drehen_gespannt || e->verloren;
+}
+
+static void instanz(const struct optionen *optionen, unsigned long index, struct anlage_ergebnis *e) {
+	struct anlage_parameter parameter;
+	int abbruch;
+
+	parameter.index = index;
+	parameter.seed = optionen->seed;
+	parameter.teile = optionen->teile;
+	parameter.rauschen = optionen->rauschen;
+	anlage_init(&parameter);
+
+	if (sim_module_init() != 0) {
+		anlage_ergebnis(e);
+		e->abbruch = SIM_VERKLEMMT;
+		return;
+	}
+	// Zeitlimit: grosszuegig 30 s pro Teil
+	abbruch = sim_laufen((RTIME) (optionen->teile + 2) * 30000000000LL, instanz_ende);
+	anlage_ergebnis(e);
+	e->abbruch = abbruch;
+	e->takte = statistik.taktzyklen;
+	e->taktzeit = statistik.laufzeit;
+	e->modul_verletzungen = statistik.verletzungen;
+}
+
+static void summieren(struct anlage_ergebnis *summe, const struct anlage_ergebnis *e) {
+	summe->simzeit += e->simzeit;
+	summe->eingelegt += e->eingelegt;
+	summe->eingelegt_ausschuss += e->eingelegt_ausschuss;
+	summe->ausgeworfen += e->ausgeworfen;
+	summe->gebohrt += e->gebohrt;
+	summe->drehungen += e->drehungen;
+	summe->ausschuss_gebohrt += e->ausschuss_gebohrt;
+	summe->drehen_gespannt += e->drehen_gespannt;
+	summe->verloren += e->verloren;
+	summe->kollisionen += e->kollisionen;
+	summe->gut_nicht_gebohrt += e->gut_nicht_gebohrt;
+	summe->doppelt_gebohrt += e->doppelt_gebohrt;
+	summe->takte += e->takte;
+	summe->taktzeit += e->taktzeit;
+	summe->modul_verletzungen += e->modul_verletzungen;
+}
+
+static void ergebnis_ausgeben(const struct anlage_ergebnis *e) {
+	printf("Instanz %lu: %s, %.1f s simuliert\n", e->index,
+			e->abbruch == SIM_OK ? "beendet" : e->abbruch == SIM_ZEITLIMIT ? "Zeitlimit" : "verklemmt",
+			e->simzeit / 1e9);
+	printf("  Teile: %lu eingelegt (%lu Ausschuss), %lu gebohrt, %lu ausgeworfen, %lu Drehungen\n",
+			e->eingelegt, e->eingelegt_ausschuss, e->gebohrt, e->ausgeworfen, e->drehungen);
+	printf("  Invarianten: %lu Ausschuss gebohrt, %lu gedreht bei gespanntem Teil, %lu Teile verloren\n",
+			e->ausschuss_gebohrt, e->drehen_gespannt, e->verloren);
+	printf("  Weitere: %lu Kollisionen, %lu Gutteile nicht gebohrt, %lu doppelt gebohrt, %lu Meldungen des Moduls\n",
+			e->kollisionen, e->gut_nicht_gebohrt, e->doppelt_gebohrt, e->modul_verletzungen);
+}
+
+static void hilfe(const char *programm) {
+	fprintf(stderr, "Aufruf: %s [-n Instanzen] [-t Teile] [-j Prozesse] [-s Seed] [-r Rauschen] [-i Instanz]\n", programm);
+	exit(2);
+}
+
+int main(int argc, char *argv[]) {
+	struct optionen optionen = { 1000, 200, 0, 1, 0.0, -1 };
+	struct anlage_ergebnis summe, e;
+	unsigned long fehlerhafte[MAX_FEHLERHAFTE];
+	unsigned long anzahl_fehlerhafte = 0, gestartet = 0, fertig = 0, laufend = 0;
+	unsigned long abgestuerzt = 0, zeitlimit = 0, verklemmt = 0;
+	struct timespec start, ende;
+	double wandzeit;
+	int rohr[2], status, opt;
+	pid_t pid;
+	unsigned long i;
+
+	while ((opt = getopt(argc, argv, "n:t:j:s:r:i:")) != -1) {
+		switch (opt) {
+		case 'n': optionen.instanzen = strtoul(optarg, NULL, 0); break;
+		case 't': optionen.teile = strtoul(optarg, NULL, 0); break;
+		case 'j': optionen.prozesse = strtoul(optarg, NULL, 0); break;
+		case 's': optionen.seed = strtoull(optarg, NULL, 0); break;
+		case 'r': optionen.rauschen = strtod(optarg, NULL); break;
+		case 'i': optionen.einzeln = strtol(optarg, NULL, 0); break;
+		default: hilfe(argv[0]);
+		}
+	}
+	if (optionen.prozesse == 0)
+		optionen.prozesse = sysconf(_SC_NPROCESSORS_ONLN);
+
+	// Einzelne Instanz mit Ausgabe des Moduls, z.B. zum Nachstellen eines Fehlers
+	if (optionen.einzeln >= 0) {
+		sim_ausgabe = 1;
+		memset(&e, 0, sizeof(e));
+		instanz(&optionen, optionen.einzeln, &e);
+		ergebnis_ausgeben(&e);
+		return instanz_fehlerhaft(&e);
+	}
+
+	if (pipe(rohr) == -1) {
+		perror("pipe");
+		return 2;
+	}
+
+	memset(&summe, 0, sizeof(summe));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	// Jede Instanz in einem eigenen Prozess, damit die statischen Variablen des Moduls frisch sind.
+	// Die Ergebnisse sind kleiner als PIPE_BUF und werden daher am Stueck in das Rohr geschrieben.
+	while (fertig < optionen.instanzen) {
+		while (laufend < optionen.prozesse && gestartet < optionen.instanzen) {
+			pid = fork();
+			if (pid == -1) {
+				perror("fork");
+				return 2;
+			}
+			if (pid == 0) {
+				close(rohr[0]);
+				memset(&e, 0, sizeof(e));
+				instanz(&optionen, gestartet, &e);
+				_exit(write(rohr[1], &e, sizeof(e)) == sizeof(e) ? 0 : 1);
+			}
+			gestartet++;
+			laufend++;
+		}
+
+		if (wait(&status) == -1) {
+			perror("wait");
+			return 2;
+		}
+		laufend--;
+		fertig++;
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			abgestuerzt++;
+			continue;
+		}
+		if (read(rohr[0], &e, sizeof(e)) != sizeof(e)) {
+			abgestuerzt++;
+			continue;
+		}
+
+		summieren(&summe, &e);
+		if (e.abbruch == SIM_ZEITLIMIT)
+			zeitlimit++;
+		else if (e.abbruch == SIM_VERKLEMMT)
+			verklemmt++;
+		if (instanz_fehlerhaft(&e) && anzahl_fehlerhafte < MAX_FEHLERHAFTE)
+			fehlerhafte[anzahl_fehlerhafte++] = e.index;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ende);
+	wandzeit = (ende.tv_sec - start.tv_sec) + (ende.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("Simulation: %lu Instanzen mit je %lu Eintraegen, %lu Prozesse, Seed %llu, Rauschen %g\n",
+			optionen.instanzen, optionen.teile, optionen.prozesse,
+			(unsigned long long) optionen.seed, optionen.rauschen);
+	printf("Laufzeit: %.1f s real fuer %.1f h simuliert (%lu Drehungen)\n",
+			wandzeit, summe.simzeit / 3.6e12, summe.drehungen);
+	printf("Teile: %lu eingelegt (%lu Ausschuss), %lu gebohrt, %lu ausgeworfen\n",
+			summe.eingelegt, summe.eingelegt_ausschuss, summe.gebohrt, summe.ausgeworfen);
+	if (summe.simzeit > 0 && summe.takte > 0)
+		printf("Durchsatz: %.1f Teile/h je Anlage, mittlere Taktzeit %.1f ms\n",
+				summe.ausgeworfen / (summe.simzeit / 3.6e12), summe.taktzeit / 1e6 / summe.takte);
+	printf("Invarianten: %lu Ausschuss gebohrt, %lu gedreht bei gespanntem Teil, %lu Teile verloren\n",
+			summe.ausschuss_gebohrt, summe.drehen_gespannt, summe.verloren);
+	printf("Weitere: %lu Kollisionen, %lu Gutteile nicht gebohrt, %lu doppelt gebohrt, %lu Meldungen des Moduls\n",
+			summe.kollisionen, summe.gut_nicht_gebohrt, summe.doppelt_gebohrt, summe.modul_verletzungen);
+	printf("Abbrueche: %lu Zeitlimit, %lu verklemmt, %lu abgestuerzt\n", zeitlimit, verklemmt, abgestuerzt);
+
+	if (anzahl_fehlerhafte > 0) {
+		printf("Fehlerhafte Instanzen (nachstellen mit -s %llu -t %lu -r %g -i <Instanz>):",
+				(unsigned long long) optionen.seed, optionen.teile, optionen.rauschen);
+		for (i = 0; i < anzahl_fehlerhafte; i++)
+			printf(" %lu", fehlerhafte[i]);
+		printf("\n");
+	}
+
+	return (anzahl_fehlerhafte > 0 || abgestuerzt > 0) ? 1 : 0;
+}
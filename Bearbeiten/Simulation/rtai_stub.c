@@ -0,0 +1,327 @@
+/* Nachbildung von RTAI und Modbus fuer die Simulation (siehe rtai_stub.h)
+ *
+ * Alle Zeiten sind virtuell und in Nanosekunden (1 count = 1 ns).
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rtai_stub.h"
+#include "Anlage.h"
+
+#define MAX_TASKS							8
+#define STACK_GROESSE						(64 * 1024)
+
+// Zustaende eines Tasks
+#define TASK_NEU							0	// initialisiert, noch nicht resumed
+#define TASK_BEREIT							1
+#define TASK_SCHLAEFT						2
+#define TASK_WARTET_EMPFANG					3
+#define TASK_WARTET_SENDEN					4
+#define TASK_WARTET_SEM						5
+#define TASK_ENDE							6	// geloescht oder beendet
+
+static RT_TASK *tasks[MAX_TASKS];
+static int anzahl_tasks;
+static RT_TASK *aktuell;
+static ucontext_t planer;
+static RTIME jetzt;
+static unsigned long reihenfolge;
+
+int sim_ausgabe;
+
+/**
+ * Koroutinen
+ * */
+
+static void bereit(RT_TASK *task) {
+	task->zustand = TASK_BEREIT;
+	task->reihenfolge = reihenfolge++;
+}
+
+// Blockiert den laufenden Task und kehrt zum Planer zurueck
+static void blockieren(int zustand, void *objekt) {
+	RT_TASK *task = aktuell;
+
+	task->zustand = zustand;
+	task->objekt = objekt;
+	task->reihenfolge = reihenfolge++;
+	swapcontext(&task->kontext, &planer);
+}
+
+// Weckt alle Tasks, die im Zustand "zustand" auf "objekt" warten
+static void wecken(int zustand, void *objekt) {
+	int i;
+
+	for (i = 0; i < anzahl_tasks; i++)
+		if (tasks[i]->zustand == zustand && tasks[i]->objekt == objekt)
+			bereit(tasks[i]);
+}
+
+// Liefert den am laengsten wartenden Task im Zustand "zustand" (auf "objekt", falls != NULL)
+static RT_TASK *erster(int zustand, void *objekt) {
+	RT_TASK *gefunden = NULL;
+	int i;
+
+	for (i = 0; i < anzahl_tasks; i++) {
+		if (tasks[i]->zustand != zustand || (objekt != NULL && tasks[i]->objekt != objekt))
+			continue;
+		if (gefunden == NULL || tasks[i]->reihenfolge < gefunden->reihenfolge)
+			gefunden = tasks[i];
+	}
+	return gefunden;
+}
+
+static void task_start(int index) {
+	RT_TASK *task = tasks[index];
+
+	task->funktion(task->daten);
+	task->zustand = TASK_ENDE;
+	// Rueckkehr zum Planer ueber uc_link
+}
+
+int sim_laufen(RTIME zeitlimit, sim_ende_t ende) {
+	RT_TASK *task;
+	int i;
+
+	while (!ende()) {
+		task = erster(TASK_BEREIT, NULL);
+		if (task != NULL) {
+			aktuell = task;
+			swapcontext(&planer, &task->kontext);
+			aktuell = NULL;
+			continue;
+		}
+
+		// Kein Task lauffaehig: Zeit bis zum naechsten Weckzeitpunkt vorstellen
+		task = NULL;
+		for (i = 0; i < anzahl_tasks; i++)
+			if (tasks[i]->zustand == TASK_SCHLAEFT && (task == NULL || tasks[i]->weckzeit < task->weckzeit))
+				task = tasks[i];
+		if (task == NULL)
+			return SIM_VERKLEMMT;
+		if (task->weckzeit > zeitlimit) {
+			anlage_fortschreiten(zeitlimit);
+			jetzt = zeitlimit;
+			return SIM_ZEITLIMIT;
+		}
+
+		anlage_fortschreiten(task->weckzeit);
+		jetzt = task->weckzeit;
+		bereit(task);
+		for (i = 0; i < anzahl_tasks; i++)
+			if (tasks[i]->zustand == TASK_SCHLAEFT && tasks[i]->weckzeit <= jetzt)
+				bereit(tasks[i]);
+	}
+	return SIM_OK;
+}
+
+/**
+ * Tasks und Zeit
+ * */
+
+int rt_task_init(RT_TASK *task, void (*funktion)(long), long daten, int stack_groesse,
+		int prioritaet, int fpu, void (*signal)(void)) {
+	if (anzahl_tasks == MAX_TASKS)
+		return -1;
+
+	memset(task, 0, sizeof(*task));
+	task->funktion = funktion;
+	task->daten = daten;
+	task->zustand = TASK_NEU;
+	task->stack = malloc(STACK_GROESSE);
+	if (task->stack == NULL)
+		return -1;
+
+	getcontext(&task->kontext);
+	task->kontext.uc_stack.ss_sp = task->stack;
+	task->kontext.uc_stack.ss_size = STACK_GROESSE;
+	task->kontext.uc_link = &planer;
+	makecontext(&task->kontext, (void (*)(void)) task_start, 1, anzahl_tasks);
+
+	tasks[anzahl_tasks++] = task;
+	return 0;
+}
+
+int rt_task_resume(RT_TASK *task) {
+	if (task->zustand == TASK_NEU)
+		bereit(task);
+	return 0;
+}
+
+int rt_task_delete(RT_TASK *task) {
+	task->zustand = TASK_ENDE;
+	if (task == aktuell)
+		blockieren(TASK_ENDE, NULL);
+	return 0;
+}
+
+void rt_sleep(RTIME dauer) {
+	aktuell->weckzeit = jetzt + (dauer > 0 ? dauer : 0);
+	blockieren(TASK_SCHLAEFT, NULL);
+}
+
+RTIME rt_get_time(void) {
+	return jetzt;
+}
+
+RTIME nano2count(RTIME ns) {
+	return ns;
+}
+
+RTIME count2nano(RTIME counts) {
+	return counts;
+}
+
+void rt_set_oneshot_mode(void) {
+}
+
+RTIME start_rt_timer(int periode) {
+	return 0;
+}
+
+void stop_rt_timer(void) {
+}
+
+int rt_printk(const char *format, ...) {
+	va_list argumente;
+	int laenge;
+
+	if (!sim_ausgabe)
+		return 0;
+	printf("[%10.3f] ", jetzt / 1e9);
+	va_start(argumente, format);
+	laenge = vprintf(format, argumente);
+	va_end(argumente);
+	return laenge;
+}
+
+/**
+ * Mailboxen und Semaphore
+ * */
+
+int rt_mbx_init(MBX *mbx, int groesse) {
+	if (groesse > (int) sizeof(mbx->puffer))
+		return -1;
+	memset(mbx, 0, sizeof(*mbx));
+	mbx->groesse = groesse;
+	return 0;
+}
+
+int rt_mbx_delete(MBX *mbx) {
+	return 0;
+}
+
+// Wie unter RTAI blockiert das Senden, bis die ganze Nachricht in der Mailbox liegt.
+int rt_mbx_send(MBX *mbx, void *nachricht, int laenge) {
+	int i;
+
+	while (mbx->groesse - mbx->anzahl < laenge)
+		blockieren(TASK_WARTET_SENDEN, mbx);
+
+	for (i = 0; i < laenge; i++)
+		mbx->puffer[(mbx->anfang + mbx->anzahl + i) % mbx->groesse] = ((uint8_t *) nachricht)[i];
+	mbx->anzahl += laenge;
+
+	wecken(TASK_WARTET_EMPFANG, mbx);
+	return 0;
+}
+
+int rt_mbx_receive(MBX *mbx, void *nachricht, int laenge) {
+	int i;
+
+	while (mbx->anzahl < laenge)
+		blockieren(TASK_WARTET_EMPFANG, mbx);
+
+	for (i = 0; i < laenge; i++)
+		((uint8_t *) nachricht)[i] = mbx->puffer[(mbx->anfang + i) % mbx->groesse];
+	mbx->anfang = (mbx->anfang + laenge) % mbx->groesse;
+	mbx->anzahl -= laenge;
+
+	wecken(TASK_WARTET_SENDEN, mbx);
+	return 0;
+}
+
+void rt_typed_sem_init(SEM *sem, int wert, int typ) {
+	sem->zaehler = wert;
+}
+
+int rt_sem_wait(SEM *sem) {
+	if (sem->zaehler > 0) {
+		sem->zaehler--;
+		return 0;
+	}
+	// rt_sem_signal uebergibt das Semaphor direkt an den Wartenden
+	blockieren(TASK_WARTET_SEM, sem);
+	return 0;
+}
+
+int rt_sem_signal(SEM *sem) {
+	RT_TASK *task = erster(TASK_WARTET_SEM, sem);
+
+	if (task != NULL)
+		bereit(task);
+	else
+		sem->zaehler++;
+	return 0;
+}
+
+int rt_sem_delete(SEM *sem) {
+	return 0;
+}
+
+/**
+ * Shared Memory
+ * */
+
+unsigned long nam2num(const char *name) {
+	unsigned long nummer = 0;
+
+	while (*name)
+		nummer = nummer * 39 + (unsigned char) *name++;
+	return nummer;
+}
+
+void *rtai_kmalloc(unsigned long name, int groesse) {
+	return calloc(1, groesse);
+}
+
+void rtai_kfree(unsigned long name) {
+}
+
+// Koroutinen werden nie unterbrochen, es gibt nichts zu sperren.
+unsigned long rt_global_save_flags_and_cli(void) {
+	return 0;
+}
+
+void rt_global_restore_flags(unsigned long flags) {
+}
+
+/**
+ * Modbus: Jeder Zugriff dauert eine zufaellige Latenz und blockiert den Task.
+ * */
+
+void modbus_init(void) {
+}
+
+int rt_modbus_connect(const char *knoten) {
+	return 1;
+}
+
+int rt_modbus_disconnect(int fd) {
+	return 0;
+}
+
+int rt_modbus_get(int fd, int bereich, int adresse, unsigned short *wert) {
+	rt_sleep(anlage_modbus_latenz());
+	*wert = (bereich == DIGITAL_IN) ? anlage_eingaenge() : anlage_ausgaenge();
+	return 0;
+}
+
+int rt_modbus_set(int fd, int bereich, int adresse, unsigned short wert) {
+	rt_sleep(anlage_modbus_latenz());
+	if (bereich == DIGITAL_OUT)
+		anlage_ausgaenge_setzen(wert);
+	return 0;
+}
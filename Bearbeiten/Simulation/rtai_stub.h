@@ -0,0 +1,103 @@
+/* Nachbildung der verwendeten RTAI- und Modbus-Schnittstellen fuer die Simulation
+ *
+ * Die RT-Tasks laufen als Koroutinen mit virtueller Zeit auf einem einzigen
+ * Prozessor, wie unter RTAI im Oneshot-Modus. Ein Task laeuft, bis er in
+ * rt_sleep, rt_mbx_*, rt_sem_wait oder rt_modbus_* blockiert. Sind alle Tasks
+ * blockiert, wird die Zeit bis zum naechsten Weckzeitpunkt vorgestellt und
+ * das Anlagenmodell (Anlage.c) entsprechend weitergerechnet.
+ */
+
+#ifndef RTAI_STUB_H
+#define RTAI_STUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <ucontext.h>
+
+typedef long long RTIME;
+
+typedef struct rt_task {
+	ucontext_t kontext;
+	void *stack;
+	void (*funktion)(long);
+	long daten;
+	int zustand;					// TASK_*
+	RTIME weckzeit;					// TASK_SCHLAEFT
+	void *objekt;					// MBX oder SEM, auf das gewartet wird
+	unsigned long reihenfolge;		// FIFO unter gleich priorisierten Tasks
+} RT_TASK;
+
+typedef struct {
+	uint8_t puffer[16];
+	int groesse;
+	int anfang;
+	int anzahl;
+} MBX;
+
+typedef struct {
+	int zaehler;
+} SEM;
+
+// Kernel-Makros
+#define MODULE_LICENSE(x)
+#define __init
+#define __exit
+#define module_init(f)			int (*sim_module_init)(void) = f;
+#define module_exit(f)			void (*sim_module_exit)(void) = f;
+#define smp_wmb()				__sync_synchronize()
+
+#define CNT_SEM					0
+#define DIGITAL_IN				0
+#define DIGITAL_OUT				1
+
+int rt_printk(const char *format, ...);
+#define printk rt_printk
+
+// Tasks und Zeit
+int rt_task_init(RT_TASK *task, void (*funktion)(long), long daten, int stack_groesse,
+		int prioritaet, int fpu, void (*signal)(void));
+int rt_task_resume(RT_TASK *task);
+int rt_task_delete(RT_TASK *task);
+void rt_sleep(RTIME dauer);
+RTIME rt_get_time(void);
+RTIME nano2count(RTIME ns);
+RTIME count2nano(RTIME counts);
+void rt_set_oneshot_mode(void);
+RTIME start_rt_timer(int periode);
+void stop_rt_timer(void);
+
+// Mailboxen und Semaphore
+int rt_mbx_init(MBX *mbx, int groesse);
+int rt_mbx_delete(MBX *mbx);
+int rt_mbx_send(MBX *mbx, void *nachricht, int laenge);
+int rt_mbx_receive(MBX *mbx, void *nachricht, int laenge);
+void rt_typed_sem_init(SEM *sem, int wert, int typ);
+int rt_sem_wait(SEM *sem);
+int rt_sem_signal(SEM *sem);
+int rt_sem_delete(SEM *sem);
+
+// Shared Memory
+unsigned long nam2num(const char *name);
+void *rtai_kmalloc(unsigned long name, int groesse);
+void rtai_kfree(unsigned long name);
+unsigned long rt_global_save_flags_and_cli(void);
+void rt_global_restore_flags(unsigned long flags);
+
+// Modbus
+void modbus_init(void);
+int rt_modbus_connect(const char *knoten);
+int rt_modbus_disconnect(int fd);
+int rt_modbus_get(int fd, int bereich, int adresse, unsigned short *wert);
+int rt_modbus_set(int fd, int bereich, int adresse, unsigned short wert);
+
+// Steuerung der Simulation (nicht Teil von RTAI)
+#define SIM_OK								0	// Abbruchbedingung erreicht
+#define SIM_ZEITLIMIT						1	// virtuelles Zeitlimit ueberschritten
+#define SIM_VERKLEMMT						2	// kein Task lauffaehig oder schlafend
+
+typedef int (*sim_ende_t)(void);
+int sim_laufen(RTIME zeitlimit, sim_ende_t ende);
+extern int sim_ausgabe;
+
+#endif /* RTAI_STUB_H */
@@ -0,0 +1,2 @@
+/* Simulation: siehe rtai_stub.h */
+#include "../rtai_stub.h"